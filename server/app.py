@@ -33,13 +33,17 @@ import os
 # CONFIGURATION
 # ==========================================
 
-DATABASE_PATH = "/home/pi/beehive-monitor/beehive_data.db"
-LOG_FILE = "/home/pi/beehive-monitor/flask_app.log"
-TEMPLATES_DIR = "/home/pi/beehive-monitor/templates"
-STATIC_DIR = "/home/pi/beehive-monitor/static"
-
-MQTT_BROKER = "localhost"
-MQTT_PORT = 1883
+# Overridable from the environment so the load-test harness can run a
+# second instance against a scratch broker and database
+BASE_DIR = os.environ.get("BEEHIVE_HOME", "/home/pi/beehive-monitor")
+DATABASE_PATH = os.path.join(BASE_DIR, "beehive_data.db")
+LOG_FILE = os.path.join(BASE_DIR, "flask_app.log")
+TEMPLATES_DIR = os.path.join(BASE_DIR, "templates")
+STATIC_DIR = os.path.join(BASE_DIR, "static")
+WEB_PORT = int(os.environ.get("BEEHIVE_WEB_PORT", "5000"))
+
+MQTT_BROKER = os.environ.get("BEEHIVE_MQTT_BROKER", "localhost")
+MQTT_PORT = int(os.environ.get("BEEHIVE_MQTT_PORT", "1883"))
 MQTT_TOPIC = "beehive/#"
 MQTT_CLIENT_ID = "beehive-flask-bridge"
 
@@ -465,7 +469,7 @@ if __name__ == '__main__':
         socketio.run(
             app,
             host='0.0.0.0',
-            port=5000,
+            port=WEB_PORT,
             debug=False,
             allow_unsafe_werkzeug=True
         )
@@ -0,0 +1,848 @@
+#!/usr/bin/env python3
+"""
+BeezScale Load-Test Harness
+===========================
+Measures how the MQTT subscriber, the Flask MQTT bridge and the REST API
+behave with a large fleet of hives and years of stored data.
+
+Author: Jeremy JEANNE
+Project: ArduiBeeScale
+License: GNU GPLv3
+
+This tool:
+- Seeds a scratch SQLite database (schema from init_database()) with
+  synthetic multi-year histories
+- Optionally starts a private mosquitto, mqtt_subscriber.py and app.py
+  against that database so the production services are left alone
+- Simulates a swarm of hives publishing firmware-shaped JSON payloads,
+  including reconnect storms and backlog replays
+- Runs fake dashboard clients against the REST and Socket.IO endpoints
+- Reports ingest throughput, publish-to-WebSocket latency and API p50/p99
+
+Usage:
+    python3 load_test.py seed --home /tmp/beehive-load --hives 200 --years 3
+    python3 load_test.py run  --home /tmp/beehive-load --spawn --hives 2000
+
+Requires (in addition to the server dependencies):
+    pip3 install "python-socketio[client]"
+"""
+
+import argparse
+import itertools
+import json
+import logging
+import math
+import os
+import random
+import resource
+import selectors
+import socket
+import sqlite3
+import subprocess
+import sys
+import threading
+import time
+import urllib.request
+from datetime import datetime, timedelta
+from pathlib import Path
+
+# ==========================================
+# CONFIGURATION
+# ==========================================
+
+DEFAULT_HOME = "/tmp/beehive-load"
+DEFAULT_BROKER = "localhost"
+DEFAULT_MQTT_PORT = 18830      # Private broker port, away from the production 1883
+DEFAULT_WEB_PORT = 5050        # Private Flask port, away from the production 5000
+
+SERVER_DIR = Path(__file__).resolve().parent
+
+# Descriptors per simulated hive: just its TCP socket, because the swarm
+# drives paho through its external-loop hooks and never calls loop(),
+# which would add a socketpair and hit select()'s 1024-descriptor limit
+FDS_PER_HIVE = 1
+FD_HEADROOM = 256             # Log files, SQLite, Python itself
+FDS_PER_DASHBOARD_CLIENT = 4  # HTTP keep-alive or Socket.IO transports
+
+HISTORY_ENDPOINT_HOURS = [24, 168, 720]   # Dashboard ranges: day, week, month
+
+# Firmware limits (arduino/arduino_wifi_mqtt.ino)
+MIN_BATTERY_V = 3.0
+MAX_BATTERY_V = 6.0
+
+# ==========================================
+# LOGGING CONFIGURATION
+# ==========================================
+
+logging.basicConfig(
+    level=logging.INFO,
+    format='%(asctime)s - %(levelname)s - %(message)s',
+    handlers=[logging.StreamHandler(sys.stdout)]
+)
+logger = logging.getLogger(__name__)
+
+# ==========================================
+# SYNTHETIC SENSOR MODEL
+# ==========================================
+
+def hive_id_for(index):
+    """Hive id matching the firmware topic format (beehive/hive-NNN)."""
+    return f"hive-{index + 1:03d}"
+
+def synth_reading(index, when, rng):
+    """
+    Build one plausible reading for a hive at a given time.
+
+    Temperature and humidity follow seasonal and daily cycles, weight follows
+    a spring nectar flow with a daily forager dip, and the battery discharges
+    in a sawtooth between recharges.
+    """
+    day_of_year = when.timetuple().tm_yday
+    hour = when.hour + when.minute / 60.0
+    season = math.sin(2 * math.pi * (day_of_year - 110) / 365.0)
+    daily = math.sin(2 * math.pi * (hour - 9) / 24.0)
+
+    temperature = 12.0 + 10.0 * season + 5.0 * daily + rng.gauss(0, 0.8)
+    humidity = 65.0 - 10.0 * daily - 5.0 * season + rng.gauss(0, 3.0)
+
+    base_weight = 25.0 + (index % 17)
+    flow = max(0.0, season) * 20.0
+    forager_dip = 0.8 if 10 <= hour < 17 else 0.0
+    weight = base_weight + flow - forager_dip + rng.gauss(0, 0.05)
+
+    cycle = (when.timestamp() / 86400.0 + index) % 30.0
+    battery = MAX_BATTERY_V - (MAX_BATTERY_V - MIN_BATTERY_V) * cycle / 30.0
+
+    return {
+        'temperature': round(temperature, 2),
+        'humidity': round(min(100.0, max(0.0, humidity)), 2),
+        'weight': round(weight, 2),
+        'battery_voltage': round(battery, 2)
+    }
+
+# ==========================================
+# DATABASE SEEDING
+# ==========================================
+
+def import_subscriber(home):
+    """Import mqtt_subscriber with its paths redirected to the scratch home."""
+    Path(home).mkdir(parents=True, exist_ok=True)
+    os.environ["BEEHIVE_HOME"] = home
+    sys.path.insert(0, str(SERVER_DIR))
+    import mqtt_subscriber
+    return mqtt_subscriber
+
+def seed_database(home, hives, years, interval_minutes, seed, reset):
+    """Create the schema and fill it with synthetic multi-year histories."""
+    subscriber = import_subscriber(home)
+    if reset and os.path.exists(subscriber.DATABASE_PATH):
+        os.remove(subscriber.DATABASE_PATH)
+        logger.info(f"Removed {subscriber.DATABASE_PATH}")
+    subscriber.init_database()
+
+    # Seeding twice would silently double every history
+    existing = count_readings(subscriber.DATABASE_PATH)
+    if existing:
+        logger.error(f"{subscriber.DATABASE_PATH} already holds {existing} readings - "
+                     f"use --reset to start over")
+        sys.exit(1)
+
+    rng = random.Random(seed)
+    end = datetime.utcnow().replace(second=0, microsecond=0)
+    start = end - timedelta(days=int(365 * years))
+    step = timedelta(minutes=interval_minutes)
+
+    conn = sqlite3.connect(subscriber.DATABASE_PATH)
+    cursor = conn.cursor()
+    total = 0
+    started = time.monotonic()
+
+    for index in range(hives):
+        hive_id = hive_id_for(index)
+        rows = []
+        when = start
+        while when <= end:
+            reading = synth_reading(index, when, rng)
+            rows.append((
+                hive_id, when.strftime('%Y-%m-%d %H:%M:%S'),
+                reading['temperature'], reading['humidity'],
+                reading['weight'], reading['battery_voltage'],
+                json.dumps(reading)
+            ))
+            when += step
+
+        cursor.execute("""
+            INSERT OR IGNORE INTO hives (hive_id, name, location)
+            VALUES (?, ?, ?)
+        """, (hive_id, hive_id, "Load test"))
+
+        cursor.executemany("""
+            INSERT INTO readings (hive_id, timestamp, temperature, humidity, weight, battery_voltage, raw_json)
+            VALUES (?, ?, ?, ?, ?, ?, ?)
+        """, rows)
+
+        cursor.execute("""
+            UPDATE hives SET last_reading = ? WHERE hive_id = ?
+        """, (end.strftime('%Y-%m-%d %H:%M:%S'), hive_id))
+
+        conn.commit()
+        total += len(rows)
+        logger.info(f"Seeded {hive_id}: {len(rows)} readings")
+
+    conn.close()
+    elapsed = time.monotonic() - started
+    logger.info(f"Seeded {total} readings for {hives} hives in {elapsed:.1f}s")
+
+def count_readings(database_path):
+    """Return the current number of stored readings."""
+    conn = sqlite3.connect(database_path, timeout=30)
+    try:
+        return conn.execute("SELECT COUNT(*) FROM readings").fetchone()[0]
+    finally:
+        conn.close()
+
+def last_reading_id(database_path):
+    """Return the highest reading id; cheap enough to poll during ingest."""
+    conn = sqlite3.connect(database_path, timeout=30)
+    try:
+        return conn.execute("SELECT COALESCE(MAX(id), 0) FROM readings").fetchone()[0]
+    finally:
+        conn.close()
+
+def stored_sequences(database_path, after_id):
+    """
+    Return the seq of every reading stored after a given id.
+
+    raw_json is kept verbatim by the subscriber, so the seq added by the
+    swarm survives; rows without one (real hives) are returned as None.
+    """
+    conn = sqlite3.connect(database_path, timeout=30)
+    try:
+        rows = conn.execute("SELECT raw_json FROM readings WHERE id > ?", (after_id,))
+        sequences = []
+        for (raw_json,) in rows:
+            try:
+                sequences.append(json.loads(raw_json).get('seq'))
+            except (TypeError, ValueError):
+                sequences.append(None)
+        return sequences
+    finally:
+        conn.close()
+
+# ==========================================
+# METRICS
+# ==========================================
+
+def percentile(samples, pct):
+    """Nearest-rank percentile of an already sorted list."""
+    if not samples:
+        return None
+    rank = max(1, math.ceil(pct / 100.0 * len(samples)))
+    return samples[rank - 1]
+
+class Recorder:
+    """Thread-safe collection of latency samples and counters."""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.samples = {}
+        self.counters = {}
+
+    def sample(self, name, seconds):
+        with self.lock:
+            self.samples.setdefault(name, []).append(seconds)
+
+    def count(self, name, amount=1):
+        with self.lock:
+            self.counters[name] = self.counters.get(name, 0) + amount
+
+    def summary(self):
+        """Per-metric count and p50/p90/p99/max in milliseconds."""
+        result = {}
+        with self.lock:
+            items = [(name, sorted(values)) for name, values in self.samples.items()]
+        for name, values in items:
+            result[name] = {
+                'count': len(values),
+                'p50_ms': round(percentile(values, 50) * 1000, 1),
+                'p90_ms': round(percentile(values, 90) * 1000, 1),
+                'p99_ms': round(percentile(values, 99) * 1000, 1),
+                'max_ms': round(values[-1] * 1000, 1)
+            }
+        return result
+
+# ==========================================
+# SIMULATED HIVE SWARM
+# ==========================================
+
+class SimulatedHive:
+    """
+    One hive with its own MQTT connection and an offline backlog.
+
+    Only the owning shard thread touches the client; the storm thread just
+    schedules outages through offline_until. The socket callbacks keep the
+    shard's selector in step with paho's socket and write interest.
+    """
+
+    def __init__(self, mqtt, index, broker, port, rng, selector):
+        self.index = index
+        self.hive_id = hive_id_for(index)
+        self.topic = f"beehive/{self.hive_id}"
+        self.broker = broker
+        self.port = port
+        self.rng = rng
+        self.backlog = []
+        self.online = False
+        self.next_publish = 0.0
+        self.next_connect = 0.0
+        self.offline_until = 0.0
+        self.selector = selector
+        self.client = mqtt.Client(client_id=f"load-{self.hive_id}", clean_session=True)
+        self.client.on_socket_open = self._on_socket_open
+        self.client.on_socket_close = self._on_socket_close
+        self.client.on_socket_register_write = self._on_socket_register_write
+        self.client.on_socket_unregister_write = self._on_socket_unregister_write
+
+    def _on_socket_open(self, client, userdata, sock):
+        self.selector.register(sock, selectors.EVENT_READ, self)
+
+    def _on_socket_close(self, client, userdata, sock):
+        try:
+            self.selector.unregister(sock)
+        except (KeyError, ValueError):
+            pass
+
+    def _on_socket_register_write(self, client, userdata, sock):
+        self.selector.modify(sock, selectors.EVENT_READ | selectors.EVENT_WRITE, self)
+
+    def _on_socket_unregister_write(self, client, userdata, sock):
+        try:
+            self.selector.modify(sock, selectors.EVENT_READ, self)
+        except (KeyError, ValueError):
+            pass
+
+    def connect(self):
+        try:
+            self.client.connect(self.broker, self.port, keepalive=60)
+            self.online = True
+        except OSError:
+            self.online = False
+        return self.online
+
+    def drop(self):
+        # Flush the DISCONNECT now; paho closes the socket once it is sent
+        self.client.disconnect()
+        self.client.loop_write()
+        self.online = False
+
+class HiveSwarm:
+    """
+    Drives many simulated hives from a few shard threads.
+
+    Each shard owns a slice of hives and pumps their sockets through its
+    own epoll-backed selector with paho's loop_read/loop_write/loop_misc,
+    so thousands of connections need neither thousands of threads nor
+    select(), which cannot watch descriptors above 1023.
+    """
+
+    RECONNECT_DELAY = 1.0  # Seconds between attempts after a failed connect
+    POLL_INTERVAL = 0.005  # Selector timeout between publish schedule checks
+    MISC_INTERVAL = 1.0    # Seconds between keepalive checks (loop_misc)
+
+    def __init__(self, args, recorder, published):
+        import paho.mqtt.client as mqtt
+
+        self.args = args
+        self.recorder = recorder
+        self.published = published
+        self.published_lock = threading.Lock()
+        self.sequence = itertools.count(1)
+        self.sent_seqs = set()
+        self.stop_event = threading.Event()
+        rng = random.Random(args.seed)
+        self.shards = [selectors.DefaultSelector()
+                       for _ in range(max(1, min(args.shards, args.hives)))]
+        self.hives = [SimulatedHive(mqtt, i, args.broker, args.mqtt_port,
+                                    random.Random(rng.random()),
+                                    self.shards[i % len(self.shards)])
+                      for i in range(args.hives)]
+        self.threads = []
+
+    def start(self):
+        now = time.monotonic()
+        for hive in self.hives:
+            hive.next_publish = now + hive.rng.uniform(0, self.args.interval)
+
+        for shard, selector in enumerate(self.shards):
+            members = self.hives[shard::len(self.shards)]
+            thread = threading.Thread(target=self._run_shard, args=(members, selector),
+                                      daemon=True)
+            thread.start()
+            self.threads.append(thread)
+
+        if self.args.storm_every > 0:
+            thread = threading.Thread(target=self._run_storms, daemon=True)
+            thread.start()
+            self.threads.append(thread)
+
+    def stop(self):
+        self.stop_event.set()
+        for thread in self.threads:
+            thread.join(timeout=10)
+
+    def _publish(self, hive, reading):
+        key = (hive.hive_id, reading['temperature'], reading['humidity'],
+               reading['weight'], reading['battery_voltage'])
+        with self.published_lock:
+            seq = next(self.sequence)
+            self.published[key] = time.monotonic()
+
+        # A unique seq lets the report tell lost readings from QoS1 resends
+        # that the subscriber stores twice
+        payload = json.dumps(dict(reading, seq=seq))
+        info = hive.client.publish(hive.topic, payload, qos=1)
+        if info.rc == 0:
+            with self.published_lock:
+                self.sent_seqs.add(seq)
+            self.recorder.count('published')
+        else:
+            self.recorder.count('publish_errors')
+
+    def _reconnect(self, hive, now):
+        """Bring a hive back online and replay what it measured while offline."""
+        if not hive.connect():
+            self.recorder.count('connect_errors')
+            hive.next_connect = now + self.RECONNECT_DELAY
+            return
+
+        self.recorder.count('connects')
+        for reading in hive.backlog:
+            self._publish(hive, reading)
+        self.recorder.count('backlog_replayed', len(hive.backlog))
+        hive.backlog.clear()
+
+    def _step(self, hive, now):
+        if hive.online and hive.offline_until > now:
+            hive.drop()
+            self.recorder.count('storm_drops')
+
+        if not hive.online and hive.offline_until <= now and hive.next_connect <= now:
+            self._reconnect(hive, now)
+
+        # Readings keep being taken while offline, like a buffering node
+        if hive.next_publish <= now:
+            reading = synth_reading(hive.index, datetime.utcnow(), hive.rng)
+            if hive.online:
+                self._publish(hive, reading)
+            else:
+                hive.backlog.append(reading)
+            hive.next_publish = now + self.args.interval
+
+    def _lost(self, hive, now):
+        hive.online = False
+        hive.next_connect = now + self.RECONNECT_DELAY
+        self.recorder.count('connection_lost')
+
+    def _pump(self, selector, members, now, misc_due):
+        """Service ready sockets, plus keepalives when they are due."""
+        for key, events in selector.select(timeout=self.POLL_INTERVAL):
+            hive = key.data
+            rc = 0
+            if events & selectors.EVENT_READ:
+                rc = hive.client.loop_read()
+            if rc == 0 and events & selectors.EVENT_WRITE:
+                rc = hive.client.loop_write()
+            if rc != 0 and hive.online:
+                self._lost(hive, now)
+
+        if misc_due:
+            for hive in members:
+                if hive.online and hive.client.loop_misc() != 0:
+                    self._lost(hive, now)
+
+    def _run_shard(self, members, selector):
+        next_misc = 0.0
+        while not self.stop_event.is_set():
+            now = time.monotonic()
+            for hive in members:
+                self._step(hive, now)
+            misc_due = now >= next_misc
+            if misc_due:
+                next_misc = now + self.MISC_INTERVAL
+            self._pump(selector, members, now, misc_due)
+
+        for hive in members:
+            if hive.online:
+                hive.drop()
+        selector.close()
+
+    def _run_storms(self):
+        """Periodically drop a fraction of the swarm so it reconnects at once."""
+        rng = random.Random(self.args.seed + 1)
+        while not self.stop_event.wait(self.args.storm_every):
+            victims = rng.sample(self.hives, int(len(self.hives) * self.args.storm_fraction))
+            logger.info(f"Reconnect storm: dropping {len(victims)} hives "
+                        f"for {self.args.storm_outage}s")
+            offline_until = time.monotonic() + self.args.storm_outage
+            for hive in victims:
+                hive.offline_until = offline_until
+
+# ==========================================
+# FAKE DASHBOARD CLIENTS
+# ==========================================
+
+def rest_client_loop(base_url, hives, recorder, stop_event, think_time, rng):
+    """Behave like a dashboard tab polling the REST API."""
+    while not stop_event.is_set():
+        hive_id = hive_id_for(rng.randrange(hives))
+        hours = rng.choice(HISTORY_ENDPOINT_HOURS)
+        requests = [
+            ('api_hives', "/api/hives"),
+            ('api_latest', f"/api/hive/{hive_id}/latest"),
+            ('api_history', f"/api/hive/{hive_id}/history?hours={hours}"),
+            ('api_stats', f"/api/hive/{hive_id}/stats?hours={hours}")
+        ]
+        for name, path in requests:
+            started = time.monotonic()
+            try:
+                with urllib.request.urlopen(base_url + path, timeout=30) as response:
+                    response.read()
+                recorder.sample(name, time.monotonic() - started)
+            except Exception:
+                recorder.count(f"{name}_errors")
+            if stop_event.is_set():
+                return
+        stop_event.wait(think_time)
+
+def socketio_client_loop(base_url, hives, recorder, published, stop_event, think_time, rng):
+    """Live dashboard: time new_reading broadcasts and request_update round trips."""
+    import socketio
+
+    sio = socketio.Client(reconnection=True)
+    reply = threading.Event()
+
+    @sio.on('new_reading')
+    def on_new_reading(data):
+        key = (data.get('hive_id'), data.get('temperature'), data.get('humidity'),
+               data.get('weight'), data.get('battery_voltage'))
+        sent = published.get(key)
+        if sent is None:
+            recorder.count('ws_unmatched')
+        else:
+            recorder.sample('publish_to_ws', time.monotonic() - sent)
+
+    @sio.on('data_update')
+    def on_data_update(data):
+        reply.set()
+
+    try:
+        sio.connect(base_url, wait_timeout=30)
+    except Exception:
+        recorder.count('ws_connect_errors')
+        return
+
+    while not stop_event.is_set():
+        reply.clear()
+        started = time.monotonic()
+        sio.emit('request_update', {'hive_id': hive_id_for(rng.randrange(hives))})
+        if reply.wait(timeout=30):
+            recorder.sample('ws_request_update', time.monotonic() - started)
+        else:
+            recorder.count('ws_request_update_timeouts')
+        stop_event.wait(think_time)
+
+    sio.disconnect()
+
+# ==========================================
+# SERVICE MANAGEMENT
+# ==========================================
+
+def spawn_services(args):
+    """Start a private broker, subscriber and web server for the run."""
+    env = dict(os.environ,
+               BEEHIVE_HOME=args.home,
+               BEEHIVE_MQTT_BROKER=args.broker,
+               BEEHIVE_MQTT_PORT=str(args.mqtt_port),
+               BEEHIVE_WEB_PORT=str(args.web_port),
+               PYTHONUNBUFFERED="1")
+    Path(args.home).mkdir(parents=True, exist_ok=True)
+    log = open(os.path.join(args.home, "load_test_services.log"), "ab")
+    processes = []
+
+    try:
+        processes.append(subprocess.Popen(["mosquitto", "-p", str(args.mqtt_port)],
+                                          stdout=log, stderr=log))
+        # app.py connects its MQTT bridge only once, so the broker must be up first
+        wait_for_tcp(args.broker, args.mqtt_port, processes[0], timeout=30)
+        for script in ("mqtt_subscriber.py", "app.py"):
+            processes.append(subprocess.Popen([sys.executable, str(SERVER_DIR / script)],
+                                              env=env, stdout=log, stderr=log))
+
+        wait_for_http(f"http://localhost:{args.web_port}/api/status", timeout=60)
+    except BaseException:
+        # Do not leave a half-started stack holding the private ports
+        stop_services(processes, log)
+        raise
+
+    return processes, log
+
+def stop_services(processes, log=None):
+    for process in reversed(processes):
+        process.terminate()
+    for process in processes:
+        try:
+            process.wait(timeout=10)
+        except subprocess.TimeoutExpired:
+            process.kill()
+    if log is not None:
+        log.close()
+
+def ensure_fd_limit(args):
+    """
+    Raise the soft descriptor limit to what the swarm needs.
+
+    Exits if the hard limit is too low, rather than letting connects fail
+    with EMFILE and be reported as broker errors.
+    """
+    needed = (args.hives * FDS_PER_HIVE + FD_HEADROOM
+              + (args.rest_clients + args.ws_clients) * FDS_PER_DASHBOARD_CLIENT)
+    soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    if soft == resource.RLIM_INFINITY or soft >= needed:
+        return
+    if hard != resource.RLIM_INFINITY and hard < needed:
+        logger.error(f"{args.hives} hives need about {needed} open files but the hard "
+                     f"limit is {hard} - raise it (ulimit -Hn) or use fewer hives")
+        sys.exit(1)
+    resource.setrlimit(resource.RLIMIT_NOFILE, (needed, hard))
+    logger.info(f"Raised open file limit from {soft} to {needed}")
+
+def wait_for_tcp(host, port, process, timeout):
+    """Wait until a spawned server accepts connections, failing if it exits."""
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        if process.poll() is not None:
+            raise RuntimeError(f"{process.args[0]} exited with code {process.returncode} "
+                               f"(is port {port} already in use?)")
+        try:
+            with socket.create_connection((host, port), timeout=1):
+                return
+        except OSError:
+            time.sleep(0.2)
+    raise RuntimeError(f"Nothing listening on {host}:{port}")
+
+def wait_for_http(url, timeout):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        try:
+            with urllib.request.urlopen(url, timeout=5):
+                return
+        except Exception:
+            time.sleep(0.5)
+    raise RuntimeError(f"Service did not answer at {url}")
+
+# ==========================================
+# LOAD RUN
+# ==========================================
+
+def run_load(args):
+    """Run the swarm and dashboard clients, then print the report."""
+    database_path = os.path.join(args.home, "beehive_data.db")
+    if not os.path.exists(database_path):
+        logger.error(f"No database at {database_path} - run the seed command first")
+        sys.exit(1)
+
+    base_url = args.api_url or f"http://localhost:{args.web_port}"
+    recorder = Recorder()
+    published = {}
+    stop_event = threading.Event()
+    rng = random.Random(args.seed)
+    ensure_fd_limit(args)
+
+    # spawn_services cleans up after itself if startup fails
+    processes, log = spawn_services(args) if args.spawn else ([], None)
+    try:
+        clients = []
+        for _ in range(args.rest_clients):
+            clients.append(threading.Thread(
+                target=rest_client_loop,
+                args=(base_url, args.hives, recorder, stop_event,
+                      args.think_time, random.Random(rng.random())),
+                daemon=True))
+        for _ in range(args.ws_clients):
+            clients.append(threading.Thread(
+                target=socketio_client_loop,
+                args=(base_url, args.hives, recorder, published, stop_event,
+                      args.think_time, random.Random(rng.random())),
+                daemon=True))
+        for thread in clients:
+            thread.start()
+
+        # MAX(id) on the AUTOINCREMENT key is an index lookup, unlike a
+        # COUNT(*) scan over the seeded history that would hold a shared
+        # lock against the subscriber's commits while ingest is timed
+        id_before = last_reading_id(database_path)
+        swarm = HiveSwarm(args, recorder, published)
+        started = time.monotonic()
+        swarm.start()
+        logger.info(f"Swarm of {args.hives} hives running for {args.duration}s")
+
+        time.sleep(args.duration)
+        publish_end = time.monotonic()
+        publish_elapsed = publish_end - started
+        id_after = last_reading_id(database_path)
+
+        # Signal the shards now but join them after the drain, so their
+        # shutdown does not blur either rate
+        swarm.stop_event.set()
+
+        # Let the subscriber drain whatever the broker still holds; ingest
+        # ends when the newest reading id last grew, not when the loop gives up
+        ingest_end = publish_end
+        drain_deadline = publish_end + args.drain
+        while time.monotonic() < drain_deadline:
+            time.sleep(0.2)
+            id_now = last_reading_id(database_path)
+            if id_now > id_after:
+                id_after = id_now
+                ingest_end = time.monotonic()
+            elif time.monotonic() - ingest_end >= 1.0:
+                break
+        ingest_elapsed = ingest_end - started
+        swarm.stop()
+
+        stop_event.set()
+        for thread in clients:
+            thread.join(timeout=35)
+
+    finally:
+        stop_services(processes, log)
+
+    ingested = id_after - id_before
+    sent = recorder.counters.get('published', 0)
+    sequences = stored_sequences(database_path, id_before)
+    swarm_rows = [seq for seq in sequences if seq is not None]
+    unique_seqs = set(swarm_rows)
+    report = {
+        'hives': args.hives,
+        'duration_s': round(publish_elapsed, 1),
+        'published': sent,
+        'publish_rate_per_s': round(sent / publish_elapsed, 1),
+        'ingested': ingested,
+        'ingest_rate_per_s': round(ingested / ingest_elapsed, 1),
+        'lost': len(swarm.sent_seqs - unique_seqs),
+        'duplicates': len(swarm_rows) - len(unique_seqs),
+        'foreign_rows': len(sequences) - len(swarm_rows),
+        'counters': dict(recorder.counters),
+        'latency': recorder.summary()
+    }
+    print_report(report)
+
+    if args.json_out:
+        with open(args.json_out, "w") as handle:
+            json.dump(report, handle, indent=2)
+        logger.info(f"Report written to {args.json_out}")
+
+    # No broadcasts at all means the MQTT bridge in app.py is not running
+    if args.ws_clients > 0 and sent > 0 and 'publish_to_ws' not in report['latency']:
+        logger.error("No new_reading broadcasts received - check the app.py MQTT bridge")
+        sys.exit(1)
+
+def print_report(report):
+    logger.info("=" * 50)
+    logger.info("BeezScale load-test report")
+    logger.info("=" * 50)
+    logger.info(f"Hives: {report['hives']}  Duration: {report['duration_s']}s")
+    logger.info(f"Published: {report['published']} ({report['publish_rate_per_s']}/s)")
+    logger.info(f"Ingested:  {report['ingested']} ({report['ingest_rate_per_s']}/s), "
+                f"lost: {report['lost']}, duplicates: {report['duplicates']}, "
+                f"other sources: {report['foreign_rows']}")
+    for name, value in sorted(report['counters'].items()):
+        logger.info(f"  {name}: {value}")
+    logger.info("-" * 50)
+    logger.info(f"{'metric':<22}{'count':>8}{'p50 ms':>10}{'p90 ms':>10}{'p99 ms':>10}{'max ms':>10}")
+    for name, stats in sorted(report['latency'].items()):
+        logger.info(f"{name:<22}{stats['count']:>8}{stats['p50_ms']:>10}"
+                    f"{stats['p90_ms']:>10}{stats['p99_ms']:>10}{stats['max_ms']:>10}")
+    logger.info("=" * 50)
+
+# ==========================================
+# MAIN
+# ==========================================
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="BeezScale fleet-scale load test")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    seed = commands.add_parser("seed", help="create and fill a scratch database")
+    seed.add_argument("--home", default=DEFAULT_HOME, help="scratch BEEHIVE_HOME directory")
+    seed.add_argument("--hives", type=int, default=100)
+    seed.add_argument("--years", type=float, default=2.0)
+    seed.add_argument("--interval-minutes", type=int, default=120,
+                      help="history spacing (firmware default is 2 hours)")
+    seed.add_argument("--reset", action="store_true",
+                      help="delete the scratch database before seeding")
+    seed.add_argument("--seed", type=int, default=1)
+
+    run = commands.add_parser("run", help="run the hive swarm and dashboard clients")
+    run.add_argument("--home", default=DEFAULT_HOME, help="scratch BEEHIVE_HOME directory")
+    run.add_argument("--spawn", action="store_true",
+                     help="start a private mosquitto, subscriber and web server")
+    run.add_argument("--broker", default=DEFAULT_BROKER)
+    run.add_argument("--mqtt-port", type=int, default=DEFAULT_MQTT_PORT)
+    run.add_argument("--web-port", type=int, default=DEFAULT_WEB_PORT)
+    run.add_argument("--api-url", help="dashboard base URL (default: local web port)")
+    run.add_argument("--hives", type=int, default=1000)
+    run.add_argument("--interval", type=float, default=10.0,
+                     help="seconds between publishes per hive")
+    run.add_argument("--shards", type=int, default=8, help="swarm pump threads")
+    run.add_argument("--duration", type=float, default=120.0, help="publishing time in seconds")
+    run.add_argument("--drain", type=float, default=60.0,
+                     help="max seconds to wait for the subscriber to catch up")
+    run.add_argument("--storm-every", type=float, default=30.0,
+                     help="seconds between reconnect storms (0 disables)")
+    run.add_argument("--storm-fraction", type=float, default=0.5,
+                     help="share of hives dropped per storm")
+    run.add_argument("--storm-outage", type=float, default=5.0,
+                     help="seconds the dropped hives stay offline")
+    run.add_argument("--rest-clients", type=int, default=10)
+    run.add_argument("--ws-clients", type=int, default=10)
+    run.add_argument("--think-time", type=float, default=1.0,
+                     help="pause between dashboard client actions")
+    run.add_argument("--json-out", help="also write the report as JSON")
+    run.add_argument("--seed", type=int, default=1)
+
+    args = parser.parse_args()
+
+    # Bad values here would otherwise only surface inside daemon threads
+    if args.hives <= 0:
+        parser.error("--hives must be greater than 0")
+    if args.command == "seed":
+        if args.years <= 0:
+            parser.error("--years must be greater than 0")
+        if args.interval_minutes <= 0:
+            parser.error("--interval-minutes must be greater than 0")
+    if args.command == "run":
+        if args.interval <= 0:
+            parser.error("--interval must be greater than 0")
+        if args.duration <= 0:
+            parser.error("--duration must be greater than 0")
+        for option in ("drain", "think_time", "storm_outage"):
+            if getattr(args, option) < 0:
+                parser.error(f"--{option.replace('_', '-')} must not be negative")
+        if not 0 <= args.storm_fraction <= 1:
+            parser.error("--storm-fraction must be between 0 and 1")
+
+    return args
+
+if __name__ == "__main__":
+    args = parse_args()
+    args.home = os.path.abspath(args.home)
+    try:
+        if args.command == "seed":
+            seed_database(args.home, args.hives, args.years, args.interval_minutes, args.seed,
+                          args.reset)
+        else:
+            run_load(args)
+    except KeyboardInterrupt:
+        logger.info("Load test stopped by user")
+        sys.exit(0)
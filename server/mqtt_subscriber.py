@@ -31,14 +31,17 @@ from pathlib import Path
 # CONFIGURATION
 # ==========================================
 
-MQTT_BROKER = "localhost"  # Mosquitto broker address
-MQTT_PORT = 1883
+# Overridable from the environment so the load-test harness can point a
+# second instance at a scratch broker and database
+MQTT_BROKER = os.environ.get("BEEHIVE_MQTT_BROKER", "localhost")  # Mosquitto broker address
+MQTT_PORT = int(os.environ.get("BEEHIVE_MQTT_PORT", "1883"))
 MQTT_TOPIC = "beehive/#"
 MQTT_CLIENT_ID = "beehive-subscriber"
 MQTT_KEEPALIVE = 60
 
-DATABASE_PATH = "/home/pi/beehive-monitor/beehive_data.db"
-LOG_FILE = "/home/pi/beehive-monitor/mqtt_subscriber.log"
+BASE_DIR = os.environ.get("BEEHIVE_HOME", "/home/pi/beehive-monitor")
+DATABASE_PATH = os.path.join(BASE_DIR, "beehive_data.db")
+LOG_FILE = os.path.join(BASE_DIR, "mqtt_subscriber.log")
 
 # Create necessary directories
 Path(DATABASE_PATH).parent.mkdir(parents=True, exist_ok=True)